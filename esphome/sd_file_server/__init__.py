@@ -1,6 +1,6 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.const import CONF_ID, CONF_PORT
+from esphome.const import CONF_ID, CONF_PATH, CONF_PORT, CONF_TYPE
 from esphome.core import coroutine_with_priority
 from .. import waveshare_sd_card
 
@@ -9,12 +9,69 @@ CONF_ROOT_PATH = "root_path"
 CONF_ENABLE_DELETION = "enable_deletion"
 CONF_ENABLE_DOWNLOAD = "enable_download"
 CONF_ENABLE_UPLOAD = "enable_upload"
+CONF_ARENA_SIZE = "arena_size"
+CONF_ARENA_IN_PSRAM = "arena_in_psram"
+CONF_MOUNTS = "mounts"
+CONF_BACKEND_ID = "backend_id"
+CONF_PARTITION = "partition"
+CONF_READ_AHEAD = "read_ahead"
+CONF_CACHE_MAX_AGE = "cache_max_age"
+CONF_READ_ONLY = "read_only"
+CONF_FALLBACK = "fallback"
+
+TYPE_SD_CARD = "sd_card"
+TYPE_SPIFFS = "spiffs"
+TYPE_VFS = "vfs"
 
 AUTO_LOAD = []
 DEPENDENCIES = ["waveshare_sd_card", "network"]
 
 sd_file_server_ns = cg.esphome_ns.namespace("sd_file_server")
 SDFileServer = sd_file_server_ns.class_("SDFileServer", cg.Component)
+DirectoryBackend = sd_file_server_ns.class_("DirectoryBackend")
+SdCardBackend = sd_file_server_ns.class_("SdCardBackend", DirectoryBackend)
+SpiffsBackend = sd_file_server_ns.class_("SpiffsBackend", DirectoryBackend)
+
+
+def mount_schema(backend_class, read_ahead, cache_max_age, read_only):
+    return cv.Schema(
+        {
+            cv.GenerateID(CONF_BACKEND_ID): cv.declare_id(backend_class),
+            cv.Required(CONF_URL_PREFIX): cv.string_strict,
+            # O buffer de download é único, na RAM interna com DMA, e tem o tamanho do maior read_ahead.
+            cv.Optional(CONF_READ_AHEAD, default=read_ahead): cv.int_range(min=256, max=16384),
+            cv.Optional(CONF_CACHE_MAX_AGE, default=cache_max_age): cv.positive_time_period_seconds,
+            cv.Optional(CONF_READ_ONLY, default=read_only): cv.boolean,
+        }
+    )
+
+
+# Cartão SD: mídia grande, leituras longas e sem cache no navegador.
+# Flash (SPIFFS ou outro sistema já montado na VFS): arquivos pequenos de UI, somente leitura e com cache.
+MOUNT_SCHEMA = cv.typed_schema(
+    {
+        TYPE_SD_CARD: mount_schema(SdCardBackend, 4096, "0s", False).extend(
+            {
+                cv.Optional(waveshare_sd_card.CONF_WAVESHARE_SD_CARD_ID): cv.use_id(waveshare_sd_card.WaveshareSdCard),
+                cv.Optional(CONF_PATH, default="/"): cv.string_strict,
+                # backend_id de outra montagem servida enquanto o cartão não termina de montar (fast_boot).
+                cv.Optional(CONF_FALLBACK): cv.use_id(DirectoryBackend),
+            }
+        ),
+        TYPE_SPIFFS: mount_schema(SpiffsBackend, 1024, "1d", True).extend(
+            {
+                cv.Optional(CONF_PARTITION): cv.string_strict,
+                cv.Optional(CONF_PATH, default="/spiffs"): cv.string_strict,
+            }
+        ),
+        TYPE_VFS: mount_schema(DirectoryBackend, 1024, "1d", True).extend(
+            {
+                cv.Required(CONF_PATH): cv.string_strict,
+            }
+        ),
+    },
+    key=CONF_TYPE,
+)
 
 CONFIG_SCHEMA = cv.All(
     cv.Schema(
@@ -27,6 +84,9 @@ CONFIG_SCHEMA = cv.All(
             cv.Optional(CONF_ENABLE_DELETION, default=True): cv.boolean,
             cv.Optional(CONF_ENABLE_DOWNLOAD, default=True): cv.boolean,
             cv.Optional(CONF_ENABLE_UPLOAD, default=True): cv.boolean,
+            cv.Optional(CONF_ARENA_SIZE, default=4096): cv.int_range(min=1024, max=65536),
+            cv.Optional(CONF_ARENA_IN_PSRAM, default=True): cv.boolean,
+            cv.Optional(CONF_MOUNTS): cv.ensure_list(MOUNT_SCHEMA),
         }
     ).extend(cv.COMPONENT_SCHEMA),
 )
@@ -43,4 +103,35 @@ async def to_code(config):
     cg.add(var.set_download_enabled(config[CONF_ENABLE_DOWNLOAD]))
     cg.add(var.set_upload_enabled(config[CONF_ENABLE_UPLOAD]))
     cg.add(var.set_port(config[CONF_PORT]))
-    cg.add_define("USE_SD_CARD_WEBSERVER")
\ No newline at end of file
+    cg.add(var.set_arena_size(config[CONF_ARENA_SIZE]))
+    cg.add(var.set_arena_in_psram(config[CONF_ARENA_IN_PSRAM]))
+    # Todos os backends são criados antes de registrar as montagens, para que um
+    # fallback possa referenciar uma montagem declarada depois.
+    backends = []
+    for mount in config.get(CONF_MOUNTS, []):
+        if mount[CONF_TYPE] == TYPE_SD_CARD:
+            card = sd_card
+            if waveshare_sd_card.CONF_WAVESHARE_SD_CARD_ID in mount:
+                card = await cg.get_variable(mount[waveshare_sd_card.CONF_WAVESHARE_SD_CARD_ID])
+            backend = cg.new_Pvariable(mount[CONF_BACKEND_ID], card, mount[CONF_PATH])
+        elif mount[CONF_TYPE] == TYPE_SPIFFS:
+            partition = mount.get(CONF_PARTITION)
+            backend = cg.new_Pvariable(mount[CONF_BACKEND_ID], mount[CONF_PATH], partition if partition is not None else cg.nullptr)
+        else:
+            backend = cg.new_Pvariable(mount[CONF_BACKEND_ID], mount[CONF_PATH])
+        backends.append((mount, backend))
+    for mount, backend in backends:
+        fallback = cg.nullptr
+        if CONF_FALLBACK in mount:
+            fallback = await cg.get_variable(mount[CONF_FALLBACK])
+        cg.add(
+            var.add_mount(
+                mount[CONF_URL_PREFIX],
+                backend,
+                mount[CONF_READ_AHEAD],
+                mount[CONF_CACHE_MAX_AGE].total_seconds,
+                mount[CONF_READ_ONLY],
+                fallback,
+            )
+        )
+    cg.add_define("USE_SD_CARD_WEBSERVER")
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include "mount_backends.h"
+#include "esphome/core/log.h"
+#include "esp_spiffs.h"
+
+namespace esphome {
+namespace sd_file_server {
+
+static const char *const TAG = "sd_file_server.mount";
+
+void SdCardBackend::setup() { this->base_path_ = this->card_->get_mount_point() + this->path_; }
+
+void SpiffsBackend::setup() {
+  if (esp_spiffs_mounted(this->partition_label_)) {
+    this->mounted_ = true;
+    return;
+  }
+
+  esp_vfs_spiffs_conf_t conf = {
+      .base_path = this->base_path_.c_str(),
+      .partition_label = this->partition_label_,
+      .max_files = 5,
+      .format_if_mount_failed = false,
+  };
+  esp_err_t ret = esp_vfs_spiffs_register(&conf);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "Falha ao montar a partição SPIFFS em %s (%s)", this->base_path_.c_str(), esp_err_to_name(ret));
+    return;
+  }
+  this->mounted_ = true;
+}
+
+}  // namespace sd_file_server
+}  // namespace esphome
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../waveshare_sd_card/waveshare_sd_card.h"
+#include "mount_table.h"
+#include <string>
+
+namespace esphome {
+namespace sd_file_server {
+
+// Cartão SD do componente waveshare_sd_card; o caminho é relativo ao ponto de montagem do cartão.
+class SdCardBackend : public DirectoryBackend {
+ public:
+  SdCardBackend(waveshare_sd_card::WaveshareSdCard *card, const std::string &path)
+      : DirectoryBackend(path), card_(card), path_(path) {}
+
+  void setup() override;
+  bool is_ready() const override { return this->card_->is_mounted(); }
+  const char *get_type() const override { return "sd_card"; }
+
+ protected:
+  waveshare_sd_card::WaveshareSdCard *card_;
+  std::string path_;
+};
+
+// Partição SPIFFS da flash interna, registrada na VFS durante o setup se ainda não estiver montada.
+class SpiffsBackend : public DirectoryBackend {
+ public:
+  SpiffsBackend(const std::string &base_path, const char *partition_label)
+      : DirectoryBackend(base_path), partition_label_(partition_label) {}
+
+  void setup() override;
+  bool is_ready() const override { return this->mounted_; }
+  // O SPIFFS não tem diretórios reais e stat() na raiz da partição falha; só a base conta como diretório.
+  bool is_directory(const char *path) const override {
+    return MountTable::normalize(this->base_path_) == MountTable::normalize(path);
+  }
+  const char *get_type() const override { return "spiffs"; }
+
+ protected:
+  const char *partition_label_;
+  bool mounted_{false};
+};
+
+}  // namespace sd_file_server
+}  // namespace esphome
@@ -0,0 +1,74 @@
+#include "mount_table.h"
+
+namespace esphome {
+namespace sd_file_server {
+
+bool DirectoryBackend::is_directory(const char *path) const { return waveshare_sd_card::directory_exists(path); }
+
+waveshare_sd_card::ListStatus DirectoryBackend::list_files(const char *path,
+                                                           const waveshare_sd_card::FileCallback &callback) const {
+  return waveshare_sd_card::list_directory(path, callback);
+}
+
+ResolvedMount Mount::resolve_backend() const {
+  bool ready = this->backend->is_ready();
+  if (!ready && this->fallback != nullptr) {
+    return ResolvedMount{this, this->fallback, true, this->fallback->is_ready(), true};
+  }
+  return ResolvedMount{this, this->backend, this->policy.read_only, ready, false};
+}
+
+std::string_view MountTable::normalize(std::string_view path) {
+  while (!path.empty() && path.back() == '/') {
+    path.remove_suffix(1);
+  }
+  return path;
+}
+
+void MountTable::add(const std::string &url_prefix, DirectoryBackend *backend, const MountPolicy &policy,
+                     DirectoryBackend *fallback) {
+  std::string prefix(normalize(url_prefix));
+  if (!prefix.empty() && prefix.front() != '/') {
+    prefix.insert(prefix.begin(), '/');
+  }
+  this->mounts_.push_back(Mount{prefix, backend, policy, fallback});
+}
+
+const Mount *MountTable::resolve(std::string_view path, std::string_view *sub_path) const {
+  const Mount *best = nullptr;
+  for (const auto &mount : this->mounts_) {
+    const std::string &prefix = mount.url_prefix;
+    if (path.substr(0, prefix.size()) != prefix) {
+      continue;
+    }
+    // O prefixo precisa terminar numa fronteira de segmento ("/ui" não cobre "/uix").
+    if (path.size() > prefix.size() && path[prefix.size()] != '/') {
+      continue;
+    }
+    if (best == nullptr || prefix.size() > best->url_prefix.size()) {
+      best = &mount;
+    }
+  }
+
+  if (best != nullptr && sub_path != nullptr) {
+    *sub_path = path.substr(best->url_prefix.size());
+  }
+  return best;
+}
+
+void MountTable::for_each_child(std::string_view path, const std::function<void(std::string_view)> &callback) const {
+  path = normalize(path);
+  for (const auto &mount : this->mounts_) {
+    std::string_view prefix = mount.url_prefix;
+    size_t pos = prefix.find_last_of('/');
+    if (prefix.empty() || pos == std::string_view::npos) {
+      continue;
+    }
+    if (prefix.substr(0, pos) == path) {
+      callback(prefix.substr(pos + 1));
+    }
+  }
+}
+
+}  // namespace sd_file_server
+}  // namespace esphome
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../waveshare_sd_card/directory.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace esphome {
+namespace sd_file_server {
+
+// Política de leitura e cache de um ponto de montagem.
+struct MountPolicy {
+  // Tamanho de cada leitura ao servir um arquivo.
+  size_t read_ahead{1024};
+  // Valor de "Cache-Control: max-age"; 0 não envia o cabeçalho.
+  uint32_t cache_max_age{0};
+  bool read_only{false};
+};
+
+// Backend padrão: um diretório qualquer da VFS (LittleFS, FAT, ou uma pasta no host).
+// Este arquivo não depende do ESP-IDF; os backends específicos ficam em mount_backends.h.
+class DirectoryBackend {
+ public:
+  explicit DirectoryBackend(const std::string &base_path) : base_path_(base_path) {}
+  virtual ~DirectoryBackend() = default;
+
+  virtual void setup() {}
+  virtual bool is_ready() const { return true; }
+  virtual bool is_directory(const char *path) const;
+  virtual waveshare_sd_card::ListStatus list_files(const char *path,
+                                                  const waveshare_sd_card::FileCallback &callback) const;
+  virtual const char *get_type() const { return "vfs"; }
+
+  const std::string &get_base_path() const { return this->base_path_; }
+
+ protected:
+  std::string base_path_;
+};
+
+struct Mount;
+
+// Backend escolhido para uma requisição. O estado do backend pode mudar no meio dela
+// (o cartão termina de montar no fast_boot), então a escolha é feita uma única vez.
+struct ResolvedMount {
+  const Mount *mount{nullptr};
+  DirectoryBackend *backend{nullptr};
+  bool read_only{false};
+  bool ready{false};
+  // O fallback está sendo servido no lugar do backend principal.
+  bool fallback{false};
+};
+
+struct Mount {
+  // Prefixo normalizado: "" para a raiz, senão "/a/b" sem barra final.
+  std::string url_prefix;
+  DirectoryBackend *backend;
+  MountPolicy policy;
+  // Servido (somente leitura) enquanto o backend não está pronto, ex.: cartão ainda montando no fast_boot.
+  DirectoryBackend *fallback{nullptr};
+
+  // Consulta is_ready() uma vez e decide entre o backend principal e o fallback.
+  ResolvedMount resolve_backend() const;
+};
+
+// Roteia cada caminho de URL para o ponto de montagem de prefixo mais longo.
+class MountTable {
+ public:
+  void add(const std::string &url_prefix, DirectoryBackend *backend, const MountPolicy &policy,
+           DirectoryBackend *fallback = nullptr);
+
+  // Retorna nullptr se nenhuma montagem cobrir o caminho; sub_path recebe o restante
+  // do caminho dentro do backend (vazio ou começando com '/').
+  const Mount *resolve(std::string_view path, std::string_view *sub_path) const;
+
+  // Chama o callback com o nome de cada montagem que é filha direta de `path`,
+  // para que apareça como diretório na listagem.
+  void for_each_child(std::string_view path, const std::function<void(std::string_view)> &callback) const;
+
+  const std::vector<Mount> &get_mounts() const { return this->mounts_; }
+  bool empty() const { return this->mounts_.empty(); }
+
+  static std::string_view normalize(std::string_view path);
+
+ protected:
+  std::vector<Mount> mounts_;
+};
+
+}  // namespace sd_file_server
+}  // namespace esphome
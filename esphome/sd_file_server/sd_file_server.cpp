@@ -1,8 +1,10 @@
 #include "sd_file_server.h"
-#include <sstream>
-#include <map>
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
 #include "esphome/core/log.h"
 #include "esphome/core/helpers.h"
+#include "esp_heap_caps.h"
 #include <cstdio>
 #include <sys/stat.h>
 
@@ -10,6 +12,62 @@ namespace esphome {
 namespace sd_file_server {
 
 static const char *const TAG = "sd_file_server";
+// Tamanho do buffer de saída (na arena) usado para enviar a listagem em chunks.
+static const size_t CHUNK_BUFFER_SIZE = 1024;
+
+// Acumula a resposta num buffer da arena e envia em chunks, sem montar o HTML inteiro na heap.
+class ChunkWriter {
+ public:
+  ChunkWriter(httpd_req_t *req, waveshare_sd_card::RequestArena &arena) : req_(req) {
+    this->buffer_ = static_cast<char *>(arena.allocate(CHUNK_BUFFER_SIZE, 1));
+  }
+
+  ChunkWriter &operator<<(std::string_view str) {
+    while (!str.empty() && this->ok_) {
+      if (this->buffer_ == nullptr) {
+        this->send_(str.data(), str.size());
+        return *this;
+      }
+      size_t n = std::min(str.size(), CHUNK_BUFFER_SIZE - this->len_);
+      memcpy(this->buffer_ + this->len_, str.data(), n);
+      this->len_ += n;
+      str.remove_prefix(n);
+      if (this->len_ == CHUNK_BUFFER_SIZE)
+        this->flush();
+    }
+    return *this;
+  }
+
+  ChunkWriter &operator<<(uint32_t value) {
+    char buf[12];
+    int n = snprintf(buf, sizeof(buf), "%" PRIu32, value);
+    return *this << std::string_view(buf, n);
+  }
+
+  void flush() {
+    if (this->len_ > 0)
+      this->send_(this->buffer_, this->len_);
+    this->len_ = 0;
+  }
+
+  // Envia o restante e o chunk vazio que finaliza a resposta.
+  void finish() {
+    this->flush();
+    if (this->ok_)
+      httpd_resp_send_chunk(this->req_, nullptr, 0);
+  }
+
+ protected:
+  void send_(const char *data, size_t len) {
+    if (this->ok_ && httpd_resp_send_chunk(this->req_, data, len) != ESP_OK)
+      this->ok_ = false;
+  }
+
+  httpd_req_t *req_;
+  char *buffer_{nullptr};
+  size_t len_{0};
+  bool ok_{true};
+};
 
 SDFileServer::SDFileServer() = default;
 
@@ -20,6 +78,33 @@ void SDFileServer::setup() {
     return;
   }
 
+  if (this->mounts_.empty()) {
+    this->default_backend_ = std::make_unique<SdCardBackend>(this->sd_card_, this->root_path_);
+    this->add_mount("/", this->default_backend_.get(), MountPolicy{}.read_ahead, 0, false);
+  }
+
+  for (const auto &mount : this->mounts_.get_mounts()) {
+    mount.backend->setup();
+    this->download_buffer_size_ = std::max(this->download_buffer_size_, mount.policy.read_ahead);
+  }
+
+  this->arena_ = std::make_unique<waveshare_sd_card::RequestArena>(this->arena_size_, this->arena_in_psram_);
+  if (!this->arena_->is_valid()) {
+    ESP_LOGE(TAG, "Falha ao alocar a arena de requisições (%u bytes)", this->arena_size_);
+    this->mark_failed();
+    return;
+  }
+
+  // O SDSPI lê direto no buffer do usuário só se ele for capaz de DMA; na PSRAM cada
+  // leitura passaria por uma cópia intermediária de 512 bytes.
+  this->download_buffer_ = static_cast<uint8_t *>(
+      heap_caps_malloc(this->download_buffer_size_, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+  if (this->download_buffer_ == nullptr) {
+    ESP_LOGE(TAG, "Falha ao alocar o buffer de download (%u bytes)", this->download_buffer_size_);
+    this->mark_failed();
+    return;
+  }
+
   ESP_LOGCONFIG(TAG, "Inicializando servidor HTTP...");
   httpd_config_t config = HTTPD_DEFAULT_CONFIG();
   config.server_port = this->port_;
@@ -50,36 +135,90 @@ void SDFileServer::dump_config() {
   ESP_LOGCONFIG(TAG, "SD File Server:");
   ESP_LOGCONFIG(TAG, "  Porta: %u", this->port_);
   ESP_LOGCONFIG(TAG, "  Prefixo da URL: %s", this->build_prefix().c_str());
-  ESP_LOGCONFIG(TAG, "  Caminho Raiz no SD: %s", this->root_path_.c_str());
+  for (const auto &mount : this->mounts_.get_mounts()) {
+    ESP_LOGCONFIG(TAG, "  Montagem %s/ -> %s (%s)", mount.url_prefix.c_str(), mount.backend->get_base_path().c_str(),
+                  mount.backend->get_type());
+    if (mount.fallback != nullptr) {
+      ESP_LOGCONFIG(TAG, "    Fallback até ficar pronto: %s (%s)", mount.fallback->get_base_path().c_str(),
+                    mount.fallback->get_type());
+    }
+    ESP_LOGCONFIG(TAG, "    Read-ahead: %u bytes, Cache max-age: %" PRIu32 "s, Somente Leitura: %s",
+                  (unsigned) mount.policy.read_ahead, mount.policy.cache_max_age, YESNO(mount.policy.read_only));
+  }
   ESP_LOGCONFIG(TAG, "  Deleção Habilitada: %s", TRUEFALSE(this->deletion_enabled_));
   ESP_LOGCONFIG(TAG, "  Download Habilitado: %s", TRUEFALSE(this->download_enabled_));
   ESP_LOGCONFIG(TAG, "  Upload Habilitado: %s", TRUEFALSE(this->upload_enabled_));
+  if (this->arena_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  Arena de Requisições: %u bytes (%s)", this->arena_->block_size(),
+                  this->arena_->in_psram() ? "PSRAM" : "RAM interna");
+  }
 }
 
-void SDFileServer::set_url_prefix(const std::string &prefix) { this->url_prefix_ = prefix; }
+void SDFileServer::set_url_prefix(const std::string &prefix) {
+  this->url_prefix_ = prefix;
+  this->prefix_ = "/" + prefix;
+}
 void SDFileServer::set_root_path(const std::string &path) { this->root_path_ = path; }
 void SDFileServer::set_sd_card(waveshare_sd_card::WaveshareSdCard *card) { this->sd_card_ = card; }
 void SDFileServer::set_deletion_enabled(bool allow) { this->deletion_enabled_ = allow; }
 void SDFileServer::set_download_enabled(bool allow) { this->download_enabled_ = allow; }
 void SDFileServer::set_upload_enabled(bool allow) { this->upload_enabled_ = allow; }
 void SDFileServer::set_port(uint16_t port) { this->port_ = port; }
+void SDFileServer::set_arena_size(size_t size) { this->arena_size_ = size; }
+void SDFileServer::set_arena_in_psram(bool psram) { this->arena_in_psram_ = psram; }
+void SDFileServer::add_mount(const std::string &url_prefix, DirectoryBackend *backend, size_t read_ahead,
+                             uint32_t cache_max_age, bool read_only, DirectoryBackend *fallback) {
+  this->mounts_.add(url_prefix, backend, MountPolicy{read_ahead, cache_max_age, read_only}, fallback);
+}
 
-std::string SDFileServer::build_prefix() const { return "/" + this->url_prefix_; }
-
-std::string SDFileServer::extract_path_from_url(const std::string &url) const {
-  std::string prefix = this->build_prefix();
-  if (url.rfind(prefix, 0) == 0) {
+std::string_view SDFileServer::extract_path_from_url(std::string_view url) const {
+  const std::string &prefix = this->build_prefix();
+  if (url.substr(0, prefix.length()) == prefix) {
     return url.substr(prefix.length());
   }
   return url;
 }
 
-std::string SDFileServer::build_absolute_path(const std::string &relative_path) const {
-    std::string path = this->root_path_ + relative_path;
-    while (path.length() > 1 && path.find("//") != std::string::npos) {
-        path.replace(path.find("//"), 2, "/");
+const char *SDFileServer::build_absolute_path(const ResolvedMount &mount, std::string_view sub_path) const {
+    std::string_view joined = this->arena_->concat({mount.backend->get_base_path(), "/", sub_path});
+    if (joined.data() == nullptr) {
+        return "";
     }
-    return "/sdcard" + path;
+    // Colapsa "//" no próprio buffer da arena.
+    char *path = const_cast<char *>(joined.data());
+    size_t out = 0;
+    for (size_t i = 0; i < joined.length(); i++) {
+        if (path[i] == '/' && out > 0 && path[out - 1] == '/') {
+            continue;
+        }
+        path[out++] = path[i];
+    }
+    if (out > 1 && path[out - 1] == '/') {
+        out--;
+    }
+    path[out] = '\0';
+    return path;
+}
+
+bool SDFileServer::resolve_mount(httpd_req_t *req, std::string_view path, std::string_view *sub_path,
+                                 ResolvedMount *resolved) const {
+    const Mount *mount = this->mounts_.resolve(path, sub_path);
+    if (mount == nullptr) {
+        send_response(req, 404, "text/plain", "Caminho não encontrado", 23);
+        return false;
+    }
+    *resolved = mount->resolve_backend();
+    if (!resolved->ready) {
+        send_response(req, 503, "text/plain", "Armazenamento indisponível", 27);
+        return false;
+    }
+    return true;
+}
+
+bool SDFileServer::has_child_mounts(std::string_view path) const {
+    bool found = false;
+    this->mounts_.for_each_child(path, [&found](std::string_view) { found = true; });
+    return found;
 }
 
 void SDFileServer::send_response(httpd_req_t *req, int status, const char *content_type, const char *body, size_t body_len) const {
@@ -91,13 +230,18 @@ void SDFileServer::send_response(httpd_req_t *req, int status, const char *conte
 }
 
 // Gera a página HTML para listar os arquivos.
-void SDFileServer::handle_index(httpd_req_t *req, const std::string &path, const std::string& relative_path) const {
-    if (!this->sd_card_->is_directory(path.c_str())) {
+void SDFileServer::handle_index(httpd_req_t *req, const ResolvedMount *mount, const char *path,
+                                std::string_view relative_path) const {
+    if (mount != nullptr && !mount->backend->is_directory(path)) {
         send_response(req, 404, "text/plain", "Not a directory", 15);
         return;
     }
 
-    std::stringstream response;
+    httpd_resp_set_type(req, "text/html");
+    ChunkWriter response(req, *this->arena_);
+    const std::string &prefix = this->build_prefix();
+    // Base para os links das entradas: na raiz fica vazia para não gerar "//" antes do nome.
+    std::string_view link_base = relative_path == "/" ? std::string_view() : relative_path;
     response << R"rawliteral(
 <!DOCTYPE html>
 <html lang="pt-br">
@@ -132,27 +276,43 @@ void SDFileServer::handle_index(httpd_req_t *req, const std::string &path, const
     )rawliteral";
 
     if (!relative_path.empty() && relative_path != "/") {
-        response << "<tr><td><span class='icon'>&#128193;</span></td><td colspan='3'><a href='" << build_prefix() << Path::parent_path(relative_path) << "'>.. (Voltar)</a></td></tr>";
+        response << "<tr><td><span class='icon'>&#128193;</span></td><td colspan='3'><a href='" << prefix << Path::parent_path(relative_path) << "'>.. (Voltar)</a></td></tr>";
     }
 
-    for (const auto &info : this->sd_card_->list_files(path.c_str())) {
-        std::string full_relative_path = Path::join(relative_path, info.name);
+    auto directory_row = [&](std::string_view name) {
         response << "<tr>";
-        if (info.is_directory) {
-            response << "<td><span class='icon'>&#128193;</span></td>"; // Ícone de pasta
-            response << "<td><a href='" << build_prefix() << full_relative_path << "'>" << info.name << "</a></td>";
-            response << "<td>-</td><td></td>";
-        } else {
+        response << "<td><span class='icon'>&#128193;</span></td>"; // Ícone de pasta
+        response << "<td><a href='" << prefix << link_base << "/" << name << "'>" << name << "</a></td>";
+        response << "<td>-</td><td></td>";
+        response << "</tr>";
+    };
+
+    // Pontos de montagem filhos aparecem como pastas, mesmo que o backend atual não os contenha.
+    this->mounts_.for_each_child(relative_path, directory_row);
+
+    bool writable = mount != nullptr && !mount->read_only;
+    if (mount != nullptr) {
+        auto status = mount->backend->list_files(path, [&](const waveshare_sd_card::FileEntry &info) {
+            if (info.is_directory) {
+                directory_row(info.name);
+                return;
+            }
+            response << "<tr>";
             response << "<td><span class='icon'>&#128441;</span></td>"; // Ícone de arquivo
-            response << "<td><a href='" << build_prefix() << full_relative_path << "'>" << info.name << "</a></td>";
+            response << "<td><a href='" << prefix << link_base << "/" << info.name << "'>" << info.name << "</a></td>";
             response << "<td>" << info.size << " B</td>";
             response << "<td>";
-            if (this->deletion_enabled_) {
-                 response << "<a href='#' class='delete-btn' onclick='if(confirm(\"Deletar " << info.name << "?\")){fetch(\"" << build_prefix() << full_relative_path << "\", {method:\"DELETE\"}).then(()=>location.reload())}'>Deletar</a>";
+            if (this->deletion_enabled_ && writable) {
+                 response << "<a href='#' class='delete-btn' onclick='if(confirm(\"Deletar " << info.name << "?\")){fetch(\"" << prefix << link_base << "/" << info.name << "\", {method:\"DELETE\"}).then(()=>location.reload())}'>Deletar</a>";
             }
             response << "</td>";
+            response << "</tr>";
+        });
+        if (status == waveshare_sd_card::LIST_OPEN_FAILED) {
+            ESP_LOGE(TAG, "Falha ao abrir diretório %s", path);
+        } else if (status == waveshare_sd_card::LIST_PATH_TOO_LONG) {
+            ESP_LOGW(TAG, "Caminho longo demais para obter tamanhos em %s", path);
         }
-        response << "</tr>";
     }
     
     response << R"rawliteral(
@@ -160,7 +320,7 @@ void SDFileServer::handle_index(httpd_req_t *req, const std::string &path, const
         </table>
     )rawliteral";
 
-    if (this->upload_enabled_) {
+    if (this->upload_enabled_ && writable) {
         response << R"rawliteral(
         <div class="upload-form">
             <h2>Upload de Arquivo</h2>
@@ -178,40 +338,64 @@ void SDFileServer::handle_index(httpd_req_t *req, const std::string &path, const
 </html>
     )rawliteral";
 
-    std::string body = response.str();
-    send_response(req, 200, "text/html", body.c_str(), body.length());
+    response.finish();
 }
 
 
 // Handler principal para requisições GET.
 void SDFileServer::handle_get(httpd_req_t *req) const {
-  std::string relative_path = this->extract_path_from_url(req->uri);
-  std::string absolute_path = this->build_absolute_path(relative_path);
+  waveshare_sd_card::ArenaScope scope(*this->arena_);
+  std::string_view relative_path = this->extract_path_from_url(req->uri);
+
+  // Diretório virtual que só contém pontos de montagem (ex.: "/" sem montagem na raiz).
+  if (this->mounts_.resolve(relative_path, nullptr) == nullptr && this->has_child_mounts(relative_path)) {
+      handle_index(req, nullptr, nullptr, relative_path);
+      return;
+  }
+
+  std::string_view sub_path;
+  ResolvedMount mount;
+  if (!this->resolve_mount(req, relative_path, &sub_path, &mount)) {
+      return;
+  }
+  const char *absolute_path = this->build_absolute_path(mount, sub_path);
   
-  if (this->sd_card_->is_directory(absolute_path.c_str())) {
-      handle_index(req, absolute_path, relative_path);
+  if (mount.backend->is_directory(absolute_path)) {
+      handle_index(req, &mount, absolute_path, relative_path);
   } else {
-      handle_download(req, absolute_path);
+      handle_download(req, mount, absolute_path);
   }
 }
 
 // Handler para download de arquivos.
-void SDFileServer::handle_download(httpd_req_t *req, const std::string &path) const {
+void SDFileServer::handle_download(httpd_req_t *req, const ResolvedMount &mount, const char *path) const {
     if (!this->download_enabled_) {
         send_response(req, 403, "text/plain", "Download desabilitado", 21);
         return;
     }
-    FILE* f = fopen(path.c_str(), "r");
+    FILE* f = fopen(path, "r");
     if (f == nullptr) {
         send_response(req, 404, "text/plain", "Arquivo não encontrado", 22);
         return;
     }
     
+    // Lê direto no buffer da montagem, sem o buffer interno do FILE, para que cada
+    // fread corresponda a uma leitura de read_ahead bytes no backend.
+    setvbuf(f, nullptr, _IONBF, 0);
+    uint8_t *buffer = this->download_buffer_;
+
     httpd_resp_set_type(req, Path::mime_type(path));
-    char buffer[1024];
+    // O conteúdo do fallback é provisório: não deixa o navegador guardá-lo no lugar do cartão.
+    const MountPolicy &policy = mount.mount->policy;
+    if (policy.cache_max_age > 0 && !mount.fallback) {
+        char cache_control[24];
+        snprintf(cache_control, sizeof(cache_control), "max-age=%" PRIu32, policy.cache_max_age);
+        // O httpd guarda só o ponteiro do valor até o envio; a arena o mantém vivo durante a requisição.
+        httpd_resp_set_hdr(req, "Cache-Control", this->arena_->store(cache_control).data());
+    }
     size_t bytes_read;
-    while ((bytes_read = fread(buffer, 1, sizeof(buffer), f)) > 0) {
-        if (httpd_resp_send_chunk(req, buffer, bytes_read) != ESP_OK) {
+    while ((bytes_read = fread(buffer, 1, policy.read_ahead, f)) > 0) {
+        if (httpd_resp_send_chunk(req, reinterpret_cast<const char *>(buffer), bytes_read) != ESP_OK) {
             fclose(f);
             return;
         }
@@ -226,8 +410,18 @@ void SDFileServer::handle_delete(httpd_req_t *req) const {
         send_response(req, 403, "text/plain", "Deleção desabilitada", 21);
         return;
     }
-    std::string path = this->build_absolute_path(this->extract_path_from_url(req->uri));
-    if (remove(path.c_str()) != 0) {
+    waveshare_sd_card::ArenaScope scope(*this->arena_);
+    std::string_view sub_path;
+    ResolvedMount mount;
+    if (!this->resolve_mount(req, this->extract_path_from_url(req->uri), &sub_path, &mount)) {
+        return;
+    }
+    if (mount.read_only) {
+        send_response(req, 403, "text/plain", "Montagem somente leitura", 24);
+        return;
+    }
+    const char *path = this->build_absolute_path(mount, sub_path);
+    if (remove(path) != 0) {
         send_response(req, 500, "text/plain", "Falha ao deletar", 16);
         return;
     }
@@ -268,11 +462,24 @@ void SDFileServer::handle_upload(httpd_req_t *req) const {
         send_response(req, 400, "text/plain", "Boundary não encontrado.", 24);
         return;
     }
-    std::string boundary = "--" + std::string(boundary_ptr + 9);
-    std::string boundary_end = boundary + "--";
+    waveshare_sd_card::ArenaScope scope(*this->arena_);
+    std::string_view boundary = this->arena_->concat({"--", boundary_ptr + 9});
+    if (boundary.data() == nullptr) {
+        send_response(req, 500, "text/plain", "Memória insuficiente", 21);
+        return;
+    }
+
+    std::string_view directory;
+    ResolvedMount mount;
+    if (!this->resolve_mount(req, this->extract_path_from_url(req->uri), &directory, &mount)) {
+        return;
+    }
+    if (mount.read_only) {
+        send_response(req, 403, "text/plain", "Montagem somente leitura", 24);
+        return;
+    }
 
     FILE *f = nullptr;
-    std::string filename;
     bool header_found = false;
     int remaining = req->content_len;
     
@@ -294,9 +501,8 @@ void SDFileServer::handle_upload(httpd_req_t *req) const {
                 const char *filename_start = header_start + 10;
                 const char *filename_end = memmem(filename_start, current_len - (filename_start - current_buf), "\"", 1);
                 if (filename_end) {
-                    filename.assign(filename_start, filename_end - filename_start);
-                    std::string full_path = this->build_absolute_path(Path::join(this->extract_path_from_url(req->uri), filename));
-                    f = fopen(full_path.c_str(), "w");
+                    std::string_view filename(filename_start, filename_end - filename_start);
+                    f = fopen(this->build_absolute_path(mount, this->arena_->concat({directory, "/", filename})), "w");
                     if (!f) {
                         send_response(req, 500, "text/plain", "Falha ao criar arquivo.", 23);
                         return;
@@ -309,7 +515,7 @@ void SDFileServer::handle_upload(httpd_req_t *req) const {
                         int data_to_write = current_len - (body_start - current_buf);
                         
                         // Verifica se o boundary final está neste mesmo buffer
-                        const char *end_marker = memmem(body_start, data_to_write, boundary.c_str(), boundary.length());
+                        const char *end_marker = memmem(body_start, data_to_write, boundary.data(), boundary.length());
                         if (end_marker) {
                             fwrite(body_start, 1, end_marker - body_start - 2 /* remove \r\n */, f);
                         } else {
@@ -320,7 +526,7 @@ void SDFileServer::handle_upload(httpd_req_t *req) const {
             }
         } else {
             // Verifica se o boundary final está neste buffer
-            const char *end_marker = memmem(current_buf, current_len, boundary.c_str(), boundary.length());
+            const char *end_marker = memmem(current_buf, current_len, boundary.data(), boundary.length());
             if (end_marker) {
                 fwrite(current_buf, 1, end_marker - current_buf - 2 /* remove \r\n */, f);
             } else {
@@ -362,11 +568,11 @@ std::string Path::file_name(const std::string &path) {
   return pos == std::string::npos ? path : path.substr(pos + 1);
 }
 
-std::string Path::parent_path(const std::string &path) {
+std::string_view Path::parent_path(std::string_view path) {
     if (path.empty() || path == "/") return "/";
     size_t pos = path.find_last_of(separator);
     if (pos == 0) return "/";
-    if (pos == std::string::npos) return "/";
+    if (pos == std::string_view::npos) return "/";
     return path.substr(0, pos);
 }
 
@@ -377,10 +583,10 @@ std::string Path::join(const std::string &base, const std::string &file) {
     return base + "/" + file;
 }
 
-const char *Path::mime_type(const std::string &path) {
+const char *Path::mime_type(std::string_view path) {
   size_t pos = path.find_last_of('.');
-  if(pos == std::string::npos) return "application/octet-stream";
-  std::string ext = path.substr(pos);
+  if(pos == std::string_view::npos) return "application/octet-stream";
+  std::string_view ext = path.substr(pos);
   if (ext == ".html" || ext == ".htm") return "text/html";
   if (ext == ".css") return "text/css";
   if (ext == ".js") return "application/javascript";
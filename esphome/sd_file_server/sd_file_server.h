@@ -4,9 +4,13 @@
 #include "esphome/components/network/util.h"
 // Inclui o cabeçalho do componente do cartão SD a partir do diretório irmão.
 #include "../waveshare_sd_card/waveshare_sd_card.h"
+#include "../waveshare_sd_card/request_arena.h"
+#include "mount_backends.h"
 #include "esp_http_server.h"
+#include <memory>
 #include <vector>
 #include <string>
+#include <string_view>
 
 namespace esphome {
 namespace sd_file_server {
@@ -27,19 +31,31 @@ class SDFileServer : public Component {
   void set_download_enabled(bool allow);
   void set_upload_enabled(bool allow);
   void set_port(uint16_t port);
+  void set_arena_size(size_t size);
+  void set_arena_in_psram(bool psram);
+  void add_mount(const std::string &url_prefix, DirectoryBackend *backend, size_t read_ahead, uint32_t cache_max_age,
+                 bool read_only, DirectoryBackend *fallback = nullptr);
 
  protected:
   // Handlers para as requisições HTTP.
-  void handle_index(httpd_req_t *req, const std::string &path, const std::string& relative_path) const;
+  // `mount` é nulo para diretórios virtuais que só contêm outros pontos de montagem.
+  void handle_index(httpd_req_t *req, const ResolvedMount *mount, const char *path,
+                    std::string_view relative_path) const;
   void handle_get(httpd_req_t *req) const;
   void handle_delete(httpd_req_t *req) const;
   void handle_upload(httpd_req_t *req) const;
-  void handle_download(httpd_req_t *req, const std::string &path) const;
+  void handle_download(httpd_req_t *req, const ResolvedMount &mount, const char *path) const;
 
   // Funções de utilidade.
-  std::string build_prefix() const;
-  std::string extract_path_from_url(const std::string &url) const;
-  std::string build_absolute_path(const std::string &path) const;
+  const std::string &build_prefix() const { return this->prefix_; }
+  std::string_view extract_path_from_url(std::string_view url) const;
+  // Retorna um caminho terminado em '\0' alocado na arena da requisição.
+  const char *build_absolute_path(const ResolvedMount &mount, std::string_view sub_path) const;
+  // Resolve a montagem e o backend da URL uma vez por requisição; se não houver montagem ou ela
+  // não estiver pronta, já envia o erro e retorna false.
+  bool resolve_mount(httpd_req_t *req, std::string_view path, std::string_view *sub_path,
+                     ResolvedMount *resolved) const;
+  bool has_child_mounts(std::string_view path) const;
   void send_response(httpd_req_t *req, int status, const char *content_type, const char *body, size_t body_len) const;
 
   // Handlers estáticos para o servidor HTTP do ESP-IDF.
@@ -51,20 +67,32 @@ class SDFileServer : public Component {
   httpd_handle_t server_{nullptr};
   waveshare_sd_card::WaveshareSdCard *sd_card_{nullptr};
   std::string url_prefix_;
+  std::string prefix_{"/"};
   std::string root_path_;
   bool deletion_enabled_{false};
   bool download_enabled_{false};
   bool upload_enabled_{false};
   uint16_t port_{80};
+  // O httpd atende uma requisição por vez numa única task, então uma só arena basta.
+  std::unique_ptr<waveshare_sd_card::RequestArena> arena_;
+  MountTable mounts_;
+  // Montagem implícita do cartão em root_path quando nenhuma "mounts" é configurada.
+  std::unique_ptr<SdCardBackend> default_backend_;
+  size_t arena_size_{4096};
+  bool arena_in_psram_{true};
+  // Buffer de download em RAM interna com DMA, do tamanho do maior read_ahead; alocado uma vez no setup.
+  uint8_t *download_buffer_{nullptr};
+  size_t download_buffer_size_{0};
 };
 
 // Estrutura de utilidade para manipulação de caminhos.
 struct Path {
   static constexpr char separator = '/';
   static std::string file_name(const std::string &path);
-  static std::string parent_path(const std::string &path);
+  // Retorna uma fatia de `path` (ou "/"), sem alocar.
+  static std::string_view parent_path(std::string_view path);
   static std::string join(const std::string &base, const std::string &file);
-  static const char *mime_type(const std::string &path);
+  static const char *mime_type(std::string_view path);
 };
 
 }  // namespace sd_file_server
@@ -1,14 +1,18 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome import pins
+from esphome import automation, pins
 from esphome.components import sensor
 from esphome.const import (
     CONF_ID,
     CONF_MODE,
     CONF_OUTPUT,
+    CONF_TRIGGER_ID,
     DEVICE_CLASS_DATA_SIZE,
+    DEVICE_CLASS_DURATION,
+    ENTITY_CATEGORY_DIAGNOSTIC,
     STATE_CLASS_MEASUREMENT,
     UNIT_BYTES,
+    UNIT_MILLISECOND,
 )
 
 DEPENDENCIES = ["esp32", "sensor"]
@@ -21,10 +25,33 @@ CONF_CS_PIN = "cs_pin"
 CONF_TOTAL_SPACE = "total_space"
 CONF_USED_SPACE = "used_space"
 CONF_FREE_SPACE = "free_space"
+CONF_MOUNT_POINT = "mount_point"
+CONF_FAST_BOOT = "fast_boot"
+CONF_SPI_HOST = "spi_host"
+CONF_MOUNT_TIME = "mount_time"
+CONF_READY_TIME = "ready_time"
+CONF_FREE_SPACE_SCAN_TIME = "free_space_scan_time"
+CONF_ON_MOUNT = "on_mount"
 
 waveshare_sd_card_ns = cg.esphome_ns.namespace("waveshare_sd_card")
 WaveshareSdCard = waveshare_sd_card_ns.class_("WaveshareSdCard", cg.Component)
 FileInfo = waveshare_sd_card_ns.struct("FileInfo")
+MountTrigger = waveshare_sd_card_ns.class_("MountTrigger", automation.Trigger.template())
+
+spi_host_device_t = cg.global_ns.enum("spi_host_device_t")
+# O CS é controlado externamente, então cada cartão precisa do seu próprio host SPI.
+SPI_HOSTS = {
+    "SPI2": spi_host_device_t.SPI2_HOST,
+    "SPI3": spi_host_device_t.SPI3_HOST,
+}
+
+BOOT_TIME_SENSOR_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_MILLISECOND,
+    device_class=DEVICE_CLASS_DURATION,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    accuracy_decimals=0,
+)
 
 CONFIG_SCHEMA = cv.Schema({
     cv.GenerateID(): cv.declare_id(WaveshareSdCard),
@@ -32,6 +59,14 @@ CONFIG_SCHEMA = cv.Schema({
     cv.Required(CONF_CMD_PIN): pins.internal_gpio_output_pin_number,
     cv.Required(CONF_DATA0_PIN): pins.internal_gpio_input_pin_number,
     cv.Optional(CONF_CS_PIN): pins.gpio_pin_schema({CONF_OUTPUT: True}),
+    cv.Optional(CONF_MOUNT_POINT, default="/sdcard"): cv.string_strict,
+    cv.Optional(CONF_FAST_BOOT, default=False): cv.boolean,
+    cv.Optional(CONF_SPI_HOST, default="SPI3"): cv.enum(SPI_HOSTS, upper=True),
+    cv.Optional(CONF_ON_MOUNT): automation.validate_automation(
+        {
+            cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(MountTrigger),
+        }
+    ),
     cv.Optional(CONF_TOTAL_SPACE): sensor.sensor_schema(
         unit_of_measurement=UNIT_BYTES,
         device_class=DEVICE_CLASS_DATA_SIZE,
@@ -50,6 +85,9 @@ CONFIG_SCHEMA = cv.Schema({
         state_class=STATE_CLASS_MEASUREMENT,
         accuracy_decimals=0,
     ),
+    cv.Optional(CONF_MOUNT_TIME): BOOT_TIME_SENSOR_SCHEMA,
+    cv.Optional(CONF_READY_TIME): BOOT_TIME_SENSOR_SCHEMA,
+    cv.Optional(CONF_FREE_SPACE_SCAN_TIME): BOOT_TIME_SENSOR_SCHEMA,
 }).extend(cv.COMPONENT_SCHEMA)
 
 async def to_code(config):
@@ -58,6 +96,9 @@ async def to_code(config):
     cg.add(var.set_clk_pin(config[CONF_CLK_PIN]))
     cg.add(var.set_cmd_pin(config[CONF_CMD_PIN]))
     cg.add(var.set_data0_pin(config[CONF_DATA0_PIN]))
+    cg.add(var.set_mount_point(config[CONF_MOUNT_POINT]))
+    cg.add(var.set_fast_boot(config[CONF_FAST_BOOT]))
+    cg.add(var.set_spi_host(config[CONF_SPI_HOST]))
     if CONF_CS_PIN in config:
         cs_pin = await cg.gpio_pin_expression(config[CONF_CS_PIN])
         cg.add(var.set_cs_pin(cs_pin))
@@ -70,3 +111,15 @@ async def to_code(config):
     if CONF_FREE_SPACE in config:
         sens = await sensor.new_sensor(config[CONF_FREE_SPACE])
         cg.add(var.set_free_space_sensor(sens))
+    if CONF_MOUNT_TIME in config:
+        sens = await sensor.new_sensor(config[CONF_MOUNT_TIME])
+        cg.add(var.set_mount_time_sensor(sens))
+    if CONF_READY_TIME in config:
+        sens = await sensor.new_sensor(config[CONF_READY_TIME])
+        cg.add(var.set_ready_time_sensor(sens))
+    if CONF_FREE_SPACE_SCAN_TIME in config:
+        sens = await sensor.new_sensor(config[CONF_FREE_SPACE_SCAN_TIME])
+        cg.add(var.set_free_space_scan_time_sensor(sens))
+    for conf in config.get(CONF_ON_MOUNT, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [], conf)
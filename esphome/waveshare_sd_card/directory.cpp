@@ -0,0 +1,93 @@
+#include "directory.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <cstring>
+
+namespace esphome {
+namespace waveshare_sd_card {
+
+bool directory_exists(const char *path) {
+  struct stat st;
+  if (stat(path, &st) == 0) {
+    return S_ISDIR(st.st_mode);
+  }
+  return false;
+}
+
+ListStatus list_directory(const char *path, const FileCallback &callback) {
+  DIR *dir = opendir(path);
+  if (dir == nullptr) {
+    return LIST_OPEN_FAILED;
+  }
+
+  // O caminho completo de cada entrada é montado num buffer fixo na pilha,
+  // evitando uma std::string temporária por arquivo.
+  char full_path[LIST_PATH_MAX];
+  size_t base_len = strlen(path);
+  // Sem espaço para "<path>/<nome>": lista só os nomes em vez de fazer stat num caminho truncado.
+  bool stat_sizes = base_len + 2 < sizeof(full_path);
+  if (stat_sizes) {
+    memcpy(full_path, path, base_len);
+    full_path[base_len++] = '/';
+  }
+  ListStatus status = stat_sizes ? LIST_OK : LIST_PATH_TOO_LONG;
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != nullptr) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+
+    FileEntry info{entry->d_name, entry->d_type == DT_DIR, 0};
+    if (!info.is_directory) {
+      if (stat_sizes && base_len + info.name.size() < sizeof(full_path)) {
+        memcpy(full_path + base_len, info.name.data(), info.name.size() + 1);
+        struct stat st;
+        if (stat(full_path, &st) == 0) {
+          info.size = st.st_size;
+        }
+      } else {
+        status = LIST_PATH_TOO_LONG;
+      }
+    }
+
+    callback(info);
+  }
+
+  closedir(dir);
+  return status;
+}
+
+bool FileListing::add(RequestArena &arena, const FileEntry &entry) {
+  Node *node = arena.create<Node>();
+  if (node == nullptr)
+    return false;
+  std::string_view name = arena.store(entry.name);
+  if (name.data() == nullptr)
+    return false;
+
+  node->entry = {name, entry.is_directory, entry.size};
+  node->next = nullptr;
+  if (this->tail_ == nullptr) {
+    this->head_ = node;
+  } else {
+    this->tail_->next = node;
+  }
+  this->tail_ = node;
+  this->count_++;
+  return true;
+}
+
+FileListing list_directory(const char *path, RequestArena &arena) {
+  FileListing listing;
+  listing.status_ = list_directory(path, [&](const FileEntry &entry) {
+    if (!listing.truncated_ && !listing.add(arena, entry)) {
+      listing.truncated_ = true;
+    }
+  });
+  return listing;
+}
+
+}  // namespace waveshare_sd_card
+}  // namespace esphome
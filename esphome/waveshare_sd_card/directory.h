@@ -0,0 +1,89 @@
+#pragma once
+
+#include "request_arena.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+// Operações de diretório sobre a VFS/POSIX, sem dependências do ESP-IDF
+// (compartilhadas com o sd_file_server e compiláveis no host).
+
+namespace esphome {
+namespace waveshare_sd_card {
+
+// Entrada de diretório sem alocação própria: o nome aponta para a arena ou,
+// na variante com callback, para o buffer do readdir (válido só durante a chamada).
+struct FileEntry {
+  std::string_view name;
+  bool is_directory;
+  uint32_t size;
+};
+
+using FileCallback = std::function<void(const FileEntry &)>;
+
+enum ListStatus : uint8_t {
+  LIST_OK = 0,
+  // O diretório não pôde ser aberto; o callback não foi chamado.
+  LIST_OPEN_FAILED,
+  // Algum caminho "<path>/<nome>" não coube no buffer: essas entradas vêm com tamanho 0.
+  LIST_PATH_TOO_LONG,
+};
+
+// Caminho absoluto máximo montado durante a listagem (prefixo de montagem + LFN do FATFS).
+static const size_t LIST_PATH_MAX = 300;
+
+bool directory_exists(const char *path);
+ListStatus list_directory(const char *path, const FileCallback &callback);
+
+// Listagem encadeada cujos nós e nomes vivem inteiramente numa RequestArena.
+class FileListing {
+ public:
+  struct Node {
+    FileEntry entry;
+    Node *next;
+  };
+
+  class Iterator {
+   public:
+    explicit Iterator(const Node *node) : node_(node) {}
+    const FileEntry &operator*() const { return this->node_->entry; }
+    const FileEntry *operator->() const { return &this->node_->entry; }
+    Iterator &operator++() {
+      this->node_ = this->node_->next;
+      return *this;
+    }
+    bool operator!=(const Iterator &other) const { return this->node_ != other.node_; }
+
+   protected:
+    const Node *node_;
+  };
+
+  // Copia a entrada (e o nome) para a arena; retorna false se a arena esgotar.
+  bool add(RequestArena &arena, const FileEntry &entry);
+
+  Iterator begin() const { return Iterator(this->head_); }
+  Iterator end() const { return Iterator(nullptr); }
+  size_t size() const { return this->count_; }
+  bool empty() const { return this->count_ == 0; }
+  ListStatus status() const { return this->status_; }
+  // false se o diretório não pôde ser aberto (diferente de um diretório vazio).
+  bool is_opened() const { return this->status_ != LIST_OPEN_FAILED; }
+  // true se a arena esgotou e nem todas as entradas foram incluídas.
+  bool is_truncated() const { return this->truncated_; }
+
+ protected:
+  friend FileListing list_directory(const char *path, RequestArena &arena);
+
+  Node *head_{nullptr};
+  Node *tail_{nullptr};
+  size_t count_{0};
+  ListStatus status_{LIST_OPEN_FAILED};
+  bool truncated_{false};
+};
+
+// Listagem materializada na arena; se ela esgotar, para de copiar e marca is_truncated().
+FileListing list_directory(const char *path, RequestArena &arena);
+
+}  // namespace waveshare_sd_card
+}  // namespace esphome
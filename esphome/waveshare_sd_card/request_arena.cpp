@@ -0,0 +1,111 @@
+#include "request_arena.h"
+#include "esp_heap_caps.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace waveshare_sd_card {
+
+RequestArena::RequestArena(size_t block_size, bool prefer_psram)
+    : block_size_(block_size), prefer_psram_(prefer_psram) {
+  this->head_ = this->new_block_(block_size, prefer_psram, &this->in_psram_);
+  this->current_ = this->head_;
+}
+
+RequestArena::~RequestArena() {
+  this->reset();
+  if (this->head_ != nullptr)
+    heap_caps_free(this->head_);
+}
+
+uint8_t *RequestArena::data_(Block *block) { return reinterpret_cast<uint8_t *>(block) + HEADER_SIZE; }
+
+RequestArena::Block *RequestArena::new_block_(size_t capacity, bool prefer_psram, bool *in_psram) {
+  void *mem = nullptr;
+  if (prefer_psram)
+    mem = heap_caps_malloc(HEADER_SIZE + capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (in_psram != nullptr)
+    *in_psram = mem != nullptr;
+  if (mem == nullptr)
+    mem = heap_caps_malloc(HEADER_SIZE + capacity, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (mem == nullptr)
+    return nullptr;
+
+  Block *block = static_cast<Block *>(mem);
+  block->next = nullptr;
+  block->capacity = capacity;
+  block->used = 0;
+  return block;
+}
+
+void *RequestArena::allocate(size_t size, size_t align) {
+  if (this->current_ == nullptr)
+    return nullptr;
+
+  Block *block = this->current_;
+  uintptr_t base = reinterpret_cast<uintptr_t>(data_(block));
+  uintptr_t start = (base + block->used + align - 1) & ~(uintptr_t) (align - 1);
+  if (start + size > base + block->capacity) {
+    // Estouro: encadeia um bloco temporário grande o suficiente para esta alocação.
+    size_t capacity = std::max(this->block_size_, size + align);
+    Block *extra = this->new_block_(capacity, this->prefer_psram_, nullptr);
+    if (extra == nullptr)
+      return nullptr;
+    block->next = extra;
+    this->current_ = block = extra;
+    base = reinterpret_cast<uintptr_t>(data_(block));
+    start = (base + align - 1) & ~(uintptr_t) (align - 1);
+  }
+
+  block->used = (start + size) - base;
+  size_t total = this->used();
+  if (total > this->peak_)
+    this->peak_ = total;
+  return reinterpret_cast<void *>(start);
+}
+
+std::string_view RequestArena::store(std::string_view str) { return this->concat({str}); }
+
+std::string_view RequestArena::concat(std::initializer_list<std::string_view> parts) {
+  size_t len = 0;
+  for (const auto &part : parts)
+    len += part.size();
+
+  char *out = static_cast<char *>(this->allocate(len + 1, 1));
+  if (out == nullptr)
+    return {};
+
+  char *p = out;
+  for (const auto &part : parts) {
+    memcpy(p, part.data(), part.size());
+    p += part.size();
+  }
+  *p = '\0';
+  return {out, len};
+}
+
+void RequestArena::reset() {
+  if (this->head_ == nullptr)
+    return;
+
+  Block *extra = this->head_->next;
+  while (extra != nullptr) {
+    Block *next = extra->next;
+    heap_caps_free(extra);
+    extra = next;
+  }
+  this->head_->next = nullptr;
+  this->head_->used = 0;
+  this->current_ = this->head_;
+}
+
+size_t RequestArena::used() const {
+  size_t total = 0;
+  for (Block *block = this->head_; block != nullptr; block = block->next)
+    total += block->used;
+  return total;
+}
+
+}  // namespace waveshare_sd_card
+}  // namespace esphome
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace esphome {
+namespace waveshare_sd_card {
+
+// Arena de alocação linear com escopo de requisição.
+//
+// O primeiro bloco é alocado uma única vez (opcionalmente na PSRAM) e reaproveitado
+// entre requisições; blocos extras só existem quando uma requisição estoura a
+// capacidade e são liberados no reset(). Nada é liberado individualmente, então
+// apenas tipos trivialmente destrutíveis podem ser criados aqui.
+class RequestArena {
+ public:
+  RequestArena(size_t block_size, bool prefer_psram);
+  ~RequestArena();
+  RequestArena(const RequestArena &) = delete;
+  RequestArena &operator=(const RequestArena &) = delete;
+
+  // Retorna nullptr somente se não houver memória para um bloco extra.
+  void *allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+  template<typename T, typename... Args> T *create(Args &&...args) {
+    static_assert(std::is_trivially_destructible<T>::value, "A arena não executa destrutores");
+    void *mem = this->allocate(sizeof(T), alignof(T));
+    return mem == nullptr ? nullptr : new (mem) T(std::forward<Args>(args)...);
+  }
+
+  // Copia a string para a arena, sempre terminada em '\0' (pode ser usada como const char *).
+  std::string_view store(std::string_view str);
+  std::string_view concat(std::initializer_list<std::string_view> parts);
+
+  // Descarta tudo o que foi alocado desde o último reset.
+  void reset();
+
+  bool is_valid() const { return this->head_ != nullptr; }
+  bool in_psram() const { return this->in_psram_; }
+  size_t block_size() const { return this->block_size_; }
+  size_t used() const;
+  size_t peak() const { return this->peak_; }
+
+ protected:
+  struct Block {
+    Block *next;
+    size_t capacity;
+    size_t used;
+  };
+  static constexpr size_t HEADER_SIZE =
+      (sizeof(Block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+  Block *new_block_(size_t capacity, bool prefer_psram, bool *in_psram);
+  static uint8_t *data_(Block *block);
+
+  Block *head_{nullptr};
+  Block *current_{nullptr};
+  size_t block_size_;
+  size_t peak_{0};
+  bool prefer_psram_;
+  bool in_psram_{false};
+};
+
+// Garante que a arena seja resetada ao final do escopo da requisição.
+class ArenaScope {
+ public:
+  explicit ArenaScope(RequestArena &arena) : arena_(arena) {}
+  ~ArenaScope() { this->arena_.reset(); }
+  ArenaScope(const ArenaScope &) = delete;
+  ArenaScope &operator=(const ArenaScope &) = delete;
+
+ protected:
+  RequestArena &arena_;
+};
+
+}  // namespace waveshare_sd_card
+}  // namespace esphome
@@ -1,15 +1,17 @@
 #include "waveshare_sd_card.h"
+#include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
 #include "esp_vfs_fat.h"
 #include "driver/sdspi_host.h" // Alterado de sdmmc_host.h
 #include "driver/spi_common.h" // Necessário para o barramento SPI
 #include "sdmmc_cmd.h"         // Mantido para a estrutura do cartão
 #include "ff.h"
+#include "diskio_sdmmc.h"
 
-#include <dirent.h>
-#include <sys/stat.h>
 #include <unistd.h>
+#include <cinttypes>
 #include <cstdio>
+#include <cstring>
 
 namespace esphome {
 namespace waveshare_sd_card {
@@ -17,6 +19,23 @@ namespace waveshare_sd_card {
 static const char *const TAG = "waveshare_sd";
 
 void WaveshareSdCard::setup() {
+  if (this->fast_boot_) {
+    ESP_LOGCONFIG(TAG, "Configurando o cartão SD (modo SPI, montagem em segundo plano)...");
+    // O CS fica no PCA9554 (I2C), então o pulso é feito pelo scheduler no loop principal
+    // em vez de vTaskDelay; só a parte SPI roda na task de montagem.
+    if (this->cs_pin_ != nullptr) {
+      this->cs_pin_->setup();
+      this->cs_pin_->digital_write(true);
+      this->set_timeout(100, [this]() {
+        this->cs_pin_->digital_write(false);
+        this->set_timeout(100, [this]() { this->start_mount_task_(); });
+      });
+    } else {
+      this->start_mount_task_();
+    }
+    return;
+  }
+
   ESP_LOGCONFIG(TAG, "Configurando o cartão SD (modo SPI)...");
 
   if (this->cs_pin_ != nullptr) {
@@ -27,12 +46,27 @@ void WaveshareSdCard::setup() {
     vTaskDelay(pdMS_TO_TICKS(100));
   }
 
+  if (!this->mount_card_()) {
+    this->mount_state_ = MOUNT_FAILED;
+    this->mark_failed();
+    return;
+  }
+  this->mount_state_ = MOUNT_READY;
+  this->scan_free_space_();
+  this->mount_handled_ = true;
+  this->on_mounted_();
+}
+
+// Inicializa o barramento SPI e monta o FAT. Pode rodar fora do loop principal:
+// não publica sensores nem chama mark_failed().
+bool WaveshareSdCard::mount_card_() {
+  uint32_t start = millis();
+
   // --- Início da nova configuração do driver SPI ---
   sdmmc_host_t host = SDSPI_HOST_DEFAULT();
   
-  // ****** ESTA É A ALTERAÇÃO CRUCIAL ******
-  // O display provavelmente está a usar SPI2_HOST. Vamos usar SPI3_HOST para evitar conflitos.
-  spi_host_device_t spi_bus = SPI3_HOST;
+  // O display provavelmente está a usar SPI2_HOST; por padrão o cartão usa SPI3_HOST (opção spi_host).
+  spi_host_device_t spi_bus = this->spi_host_;
   host.slot = spi_bus;
 
   spi_bus_config_t bus_cfg = {
@@ -45,12 +79,12 @@ void WaveshareSdCard::setup() {
   };
 
   esp_err_t ret = spi_bus_initialize(spi_bus, &bus_cfg, SDSPI_DEFAULT_DMA);
+  this->spi_bus_owner_ = ret == ESP_OK;
   if (ret != ESP_OK) {
     // Se o barramento já estiver inicializado, não há problema, podemos tentar usá-lo.
     if (ret != ESP_ERR_INVALID_STATE) {
       ESP_LOGE(TAG, "Falha ao inicializar o barramento SPI (%s)", esp_err_to_name(ret));
-      this->mark_failed();
-      return;
+      return false;
     }
     ESP_LOGW(TAG, "O barramento SPI %d já estava inicializado. A tentar reutilizá-lo.", spi_bus);
   }
@@ -67,21 +101,95 @@ void WaveshareSdCard::setup() {
   };
   
   // Usa a função de montagem específica para SPI
-  ret = esp_vfs_fat_sdspi_mount("/sdcard", &host, &device_cfg, &mount_config, &this->card_);
+  ret = esp_vfs_fat_sdspi_mount(this->mount_point_.c_str(), &host, &device_cfg, &mount_config, &this->card_);
   if (ret != ESP_OK) {
     ESP_LOGE(TAG, "Falha ao inicializar o cartão em modo SPI (%s).", esp_err_to_name(ret));
-    spi_bus_free(spi_bus);
-    this->mark_failed();
-    return;
+    if (this->spi_bus_owner_) {
+      spi_bus_free(spi_bus);
+      this->spi_bus_owner_ = false;
+    }
+    return false;
+  }
+
+  this->drive_[0] = '0' + ff_diskio_get_pdrv_card(this->card_);
+  this->mount_duration_ = millis() - start;
+  this->ready_at_ = millis();
+  return true;
+}
+
+void WaveshareSdCard::start_mount_task_() {
+  if (xTaskCreate(WaveshareSdCard::mount_task_, "sd_mount", 4096, this, 1, nullptr) != pdPASS) {
+    ESP_LOGE(TAG, "Falha ao criar a task de montagem do cartão SD");
+    this->mount_state_ = MOUNT_FAILED;
   }
+}
+
+void WaveshareSdCard::mount_task_(void *arg) {
+  WaveshareSdCard *self = static_cast<WaveshareSdCard *>(arg);
+  bool mounted = self->mount_card_();
+  self->mount_state_ = mounted ? MOUNT_READY : MOUNT_FAILED;
+  // O cartão já fica disponível enquanto a primeira varredura roda aqui, fora do loop principal.
+  if (mounted)
+    self->scan_free_space_();
+  vTaskDelete(nullptr);
+}
 
-  ESP_LOGI(TAG, "Cartão SD montado com sucesso em /sdcard (modo SPI)!");
-  sdmmc_card_print_info(stdout, this->card_);
-  this->update_sensors_();
+// Primeira leitura de espaço, cronometrada. Em cartões sem FSINFO o f_getfree percorre a
+// FAT inteira; depois o FATFS mantém a contagem em cache e as leituras seguintes são rápidas.
+// Não publica sensores: o loop principal faz isso quando vê free_space_scanned_.
+void WaveshareSdCard::scan_free_space_() {
+  uint32_t start = millis();
+  this->scan_ok_ = this->read_free_space_(&this->scan_total_bytes_, &this->scan_free_bytes_);
+  this->free_space_scan_duration_ = millis() - start;
+  this->free_space_scanned_ = true;
+}
+
+// Executado no loop principal assim que o cartão fica pronto.
+void WaveshareSdCard::on_mounted_() {
+  ESP_LOGI(TAG, "Cartão SD montado com sucesso em %s (modo SPI) em %" PRIu32 " ms!", this->mount_point_.c_str(),
+           this->mount_duration_);
+  if (this->mount_time_sensor_ != nullptr)
+    this->mount_time_sensor_->publish_state(this->mount_duration_);
+  if (this->ready_time_sensor_ != nullptr)
+    this->ready_time_sensor_->publish_state(this->ready_at_);
+
+  if (this->fast_boot_) {
+    // Só um resumo em vez do sdmmc_card_print_info, para não segurar o loop no boot.
+    ESP_LOGI(TAG, "Cartão: %s, %" PRIu64 " MB", this->card_->cid.name,
+             (uint64_t) this->card_->csd.capacity * this->card_->csd.sector_size / (1024 * 1024));
+  } else {
+    sdmmc_card_print_info(stdout, this->card_);
+  }
+
+  this->mount_callback_.call();
 }
 
 // ... (o resto do ficheiro permanece o mesmo) ...
 void WaveshareSdCard::loop() {
+  if (!this->mount_handled_) {
+    uint8_t state = this->mount_state_.load();
+    if (state == MOUNT_PENDING)
+      return;
+    this->mount_handled_ = true;
+    if (state == MOUNT_FAILED) {
+      this->mark_failed();
+      return;
+    }
+    this->on_mounted_();
+  }
+
+  if (!this->free_space_published_) {
+    // No fast_boot a primeira varredura ainda pode estar rodando na task de montagem.
+    if (!this->free_space_scanned_.load())
+      return;
+    this->free_space_published_ = true;
+    this->last_update_ = millis();
+    if (this->free_space_scan_time_sensor_ != nullptr)
+      this->free_space_scan_time_sensor_->publish_state(this->free_space_scan_duration_);
+    if (this->scan_ok_)
+      this->publish_free_space_(this->scan_total_bytes_, this->scan_free_bytes_);
+  }
+
   if (millis() - this->last_update_ > 30000) {
     this->last_update_ = millis();
     this->update_sensors_();
@@ -89,71 +197,71 @@ void WaveshareSdCard::loop() {
 }
 
 void WaveshareSdCard::update_sensors_() {
-  if (this->is_failed() || this->card_ == nullptr)
+  if (this->is_failed() || !this->is_mounted())
     return;
 
+  uint64_t total_bytes, free_bytes;
+  if (this->read_free_space_(&total_bytes, &free_bytes))
+    this->publish_free_space_(total_bytes, free_bytes);
+}
+
+// Pode rodar na task de montagem: só lê o FATFS, sem publicar nada.
+bool WaveshareSdCard::read_free_space_(uint64_t *total_bytes, uint64_t *free_bytes) {
   FATFS *fs;
   DWORD fre_clust;
-  if (f_getfree("0:", &fre_clust, &fs) != FR_OK) {
+  if (f_getfree(this->drive_, &fre_clust, &fs) != FR_OK) {
     ESP_LOGW(TAG, "Falha ao obter informações de espaço do cartão SD.");
-    return;
+    return false;
   }
+  *total_bytes = (uint64_t)(fs->n_fatent - 2) * fs->csize * this->card_->csd.sector_size;
+  *free_bytes = (uint64_t)fre_clust * fs->csize * this->card_->csd.sector_size;
+  return true;
+}
 
-  uint64_t total_bytes = (uint64_t)(fs->n_fatent - 2) * fs->csize * this->card_->csd.sector_size;
-  uint64_t free_bytes = (uint64_t)fre_clust * fs->csize * this->card_->csd.sector_size;
-  uint64_t used_bytes = total_bytes - free_bytes;
-
+void WaveshareSdCard::publish_free_space_(uint64_t total_bytes, uint64_t free_bytes) {
   if (this->total_space_sensor_ != nullptr)
     this->total_space_sensor_->publish_state(total_bytes);
   if (this->used_space_sensor_ != nullptr)
-    this->used_space_sensor_->publish_state(used_bytes);
+    this->used_space_sensor_->publish_state(total_bytes - free_bytes);
   if (this->free_space_sensor_ != nullptr)
     this->free_space_sensor_->publish_state(free_bytes);
 }
 
-bool WaveshareSdCard::is_directory(const char *path) {
-  struct stat st;
-  if (stat(path, &st) == 0) {
-    return S_ISDIR(st.st_mode);
-  }
-  return false;
-}
+bool WaveshareSdCard::is_directory(const char *path) { return directory_exists(path); }
 
 std::vector<FileInfo> WaveshareSdCard::list_files(const char *path) {
   std::vector<FileInfo> files;
-  DIR *dir = opendir(path);
-  if (dir == nullptr) {
+  this->list_files(path, [&files](const FileEntry &entry) {
+    files.push_back(FileInfo{std::string(entry.name), entry.is_directory, entry.size});
+  });
+  return files;
+}
+
+FileListing WaveshareSdCard::list_files(const char *path, RequestArena &arena) {
+  FileListing listing = list_directory(path, arena);
+  if (!listing.is_opened()) {
     ESP_LOGE(TAG, "Falha ao abrir diretório %s", path);
-    return files;
+    return listing;
   }
-
-  struct dirent *entry;
-  while ((entry = readdir(dir)) != nullptr) {
-    if (entry->d_name[0] == '.') {
-      continue;
-    }
-
-    FileInfo info;
-    info.name = entry->d_name;
-    info.is_directory = (entry->d_type == DT_DIR);
-    
-    if (!info.is_directory) {
-      std::string full_path = std::string(path) + "/" + info.name;
-      struct stat st;
-      if (stat(full_path.c_str(), &st) == 0) {
-        info.size = st.st_size;
-      } else {
-        info.size = 0;
-      }
-    } else {
-        info.size = 0;
-    }
-    
-    files.push_back(info);
+  if (listing.status() == LIST_PATH_TOO_LONG) {
+    ESP_LOGW(TAG, "Caminho longo demais para obter tamanhos em %s", path);
   }
+  if (listing.is_truncated()) {
+    ESP_LOGW(TAG, "Arena esgotada ao listar %s; listagem truncada em %u entradas", path, listing.size());
+  }
+  return listing;
+}
 
-  closedir(dir);
-  return files;
+bool WaveshareSdCard::list_files(const char *path, const FileCallback &callback) {
+  ListStatus status = list_directory(path, callback);
+  if (status == LIST_OPEN_FAILED) {
+    ESP_LOGE(TAG, "Falha ao abrir diretório %s", path);
+    return false;
+  }
+  if (status == LIST_PATH_TOO_LONG) {
+    ESP_LOGW(TAG, "Caminho longo demais para obter tamanhos em %s", path);
+  }
+  return true;
 }
 
 void WaveshareSdCard::dump_config() {
@@ -161,10 +269,16 @@ void WaveshareSdCard::dump_config() {
   ESP_LOGCONFIG(TAG, "  CLK Pin: %u", this->clk_pin_);
   ESP_LOGCONFIG(TAG, "  CMD Pin: %u", this->cmd_pin_);
   ESP_LOGCONFIG(TAG, "  D0 Pin: %u", this->data0_pin_);
+  ESP_LOGCONFIG(TAG, "  Host SPI: SPI%d", this->spi_host_ + 1);
+  ESP_LOGCONFIG(TAG, "  Ponto de Montagem: %s", this->mount_point_.c_str());
+  ESP_LOGCONFIG(TAG, "  Fast Boot: %s", YESNO(this->fast_boot_));
   LOG_PIN("  CS Pin: ", this->cs_pin_);
   LOG_SENSOR("  ", "Total Space Sensor", this->total_space_sensor_);
   LOG_SENSOR("  ", "Used Space Sensor", this->used_space_sensor_);
   LOG_SENSOR("  ", "Free Space Sensor", this->free_space_sensor_);
+  LOG_SENSOR("  ", "Mount Time Sensor", this->mount_time_sensor_);
+  LOG_SENSOR("  ", "Ready Time Sensor", this->ready_time_sensor_);
+  LOG_SENSOR("  ", "Free Space Scan Time Sensor", this->free_space_scan_time_sensor_);
 }
 
 bool WaveshareSdCard::write_file(const char *path, const uint8_t *data, size_t len) {
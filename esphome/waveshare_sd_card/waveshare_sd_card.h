@@ -1,12 +1,19 @@
 #pragma once
 
+#include "esphome/core/automation.h"
 #include "esphome/core/component.h"
 #include "esphome/core/hal.h"
 #include "esphome/components/sensor/sensor.h"
 #include "driver/sdmmc_host.h"
+#include "driver/spi_common.h"
 #include "sdmmc_cmd.h"
+#include "directory.h"
+#include "request_arena.h"
+#include <atomic>
+#include <functional>
 #include <vector>
 #include <string>
+#include <string_view>
 
 namespace esphome {
 namespace waveshare_sd_card {
@@ -17,6 +24,12 @@ struct FileInfo {
   uint32_t size;
 };
 
+enum MountState : uint8_t {
+  MOUNT_PENDING = 0,
+  MOUNT_READY,
+  MOUNT_FAILED,
+};
+
 class WaveshareSdCard : public Component {
  public:
   void set_clk_pin(uint8_t pin) { clk_pin_ = pin; }
@@ -26,6 +39,14 @@ class WaveshareSdCard : public Component {
   void set_total_space_sensor(sensor::Sensor *s) { total_space_sensor_ = s; }
   void set_used_space_sensor(sensor::Sensor *s) { used_space_sensor_ = s; }
   void set_free_space_sensor(sensor::Sensor *s) { free_space_sensor_ = s; }
+  void set_mount_point(const std::string &mount_point) { mount_point_ = mount_point; }
+  void set_fast_boot(bool fast_boot) { fast_boot_ = fast_boot; }
+  void set_spi_host(spi_host_device_t spi_host) { spi_host_ = spi_host; }
+  void set_mount_time_sensor(sensor::Sensor *s) { mount_time_sensor_ = s; }
+  void set_ready_time_sensor(sensor::Sensor *s) { ready_time_sensor_ = s; }
+  void set_free_space_scan_time_sensor(sensor::Sensor *s) { free_space_scan_time_sensor_ = s; }
+  void add_on_mount_callback(std::function<void()> &&callback) { mount_callback_.add(std::move(callback)); }
+  const std::string &get_mount_point() const { return mount_point_; }
 
   void setup() override;
   void dump_config() override;
@@ -34,13 +55,27 @@ class WaveshareSdCard : public Component {
   // A prioridade LATE força este componente a arrancar depois dos outros, como o pca9554.
   float get_setup_priority() const override { return setup_priority::LATE; }
 
+  // No modo fast_boot o cartão é montado numa task em segundo plano; até lá os acessos falham.
+  bool is_mounted() const { return this->mount_state_.load() == MOUNT_READY; }
+
   bool is_directory(const char *path);
   std::vector<FileInfo> list_files(const char *path);
+  // Percorre o diretório sem materializar a listagem; retorna false se não puder abri-lo.
+  bool list_files(const char *path, const FileCallback &callback);
+  // Listagem com nós e nomes alocados na arena da requisição.
+  FileListing list_files(const char *path, RequestArena &arena);
   bool write_file(const char *path, const uint8_t *data, size_t len);
   bool append_file(const char *path, const uint8_t *data, size_t len);
 
  protected:
+  bool mount_card_();
+  void start_mount_task_();
+  static void mount_task_(void *arg);
+  void on_mounted_();
+  void scan_free_space_();
   void update_sensors_();
+  bool read_free_space_(uint64_t *total_bytes, uint64_t *free_bytes);
+  void publish_free_space_(uint64_t total_bytes, uint64_t free_bytes);
 
   uint8_t clk_pin_;
   uint8_t cmd_pin_;
@@ -49,8 +84,41 @@ class WaveshareSdCard : public Component {
   sensor::Sensor *total_space_sensor_{nullptr};
   sensor::Sensor *used_space_sensor_{nullptr};
   sensor::Sensor *free_space_sensor_{nullptr};
+  sensor::Sensor *mount_time_sensor_{nullptr};
+  sensor::Sensor *ready_time_sensor_{nullptr};
+  sensor::Sensor *free_space_scan_time_sensor_{nullptr};
+  CallbackManager<void()> mount_callback_;
   sdmmc_card_t *card_{nullptr};
+  std::string mount_point_{"/sdcard"};
+  // Unidade lógica do FATFS ("0:", "1:", ...) atribuída na montagem; permite mais de um cartão.
+  char drive_[3]{'0', ':', '\0'};
+  // O CS fica fixo pelo PCA9554, então cada cartão precisa de um host SPI só seu.
+  spi_host_device_t spi_host_{SPI3_HOST};
+  // Só libera o barramento em caso de falha se foi esta instância que o inicializou.
+  bool spi_bus_owner_{false};
   uint32_t last_update_{0};
+  bool fast_boot_{false};
+  // Escrito pela task de montagem e lido pelo loop principal.
+  std::atomic<uint8_t> mount_state_{MOUNT_PENDING};
+  bool mount_handled_{false};
+  // Resultado da primeira varredura de espaço; os campos scan_* só são lidos pelo
+  // loop depois que free_space_scanned_ fica true.
+  std::atomic<bool> free_space_scanned_{false};
+  bool free_space_published_{false};
+  bool scan_ok_{false};
+  uint64_t scan_total_bytes_{0};
+  uint64_t scan_free_bytes_{0};
+  uint32_t free_space_scan_duration_{0};
+  // Tempos da fase de boot, em ms (medidos com millis()).
+  uint32_t mount_duration_{0};
+  uint32_t ready_at_{0};
+};
+
+class MountTrigger : public Trigger<> {
+ public:
+  explicit MountTrigger(WaveshareSdCard *parent) {
+    parent->add_on_mount_callback([this]() { this->trigger(); });
+  }
 };
 
 }  // namespace waveshare_sd_card
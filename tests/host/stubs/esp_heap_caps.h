@@ -0,0 +1,25 @@
+#pragma once
+// Substituto de host para o esp_heap_caps.h do ESP-IDF, usado pela RequestArena.
+#include <cstddef>
+#include <cstdlib>
+
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_8BIT (1 << 2)
+
+// O host não tem PSRAM. Com stub_heap_caps_allocs_left >= 0, só esse número de
+// alocações é atendido, para simular a heap esgotada.
+inline int stub_heap_caps_allocs_left = -1;
+
+inline void *heap_caps_malloc(size_t size, int caps) {
+  if (caps & MALLOC_CAP_SPIRAM)
+    return nullptr;
+  if (stub_heap_caps_allocs_left == 0)
+    return nullptr;
+  if (stub_heap_caps_allocs_left > 0)
+    stub_heap_caps_allocs_left--;
+  return malloc(size);
+}
+
+inline void heap_caps_free(void *ptr) { free(ptr); }
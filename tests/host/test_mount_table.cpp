@@ -0,0 +1,184 @@
+// Testes de host do MountTable e do DirectoryBackend (sem ESP-IDF).
+#undef NDEBUG
+#include "sd_file_server/mount_table.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace esphome::sd_file_server;
+using esphome::waveshare_sd_card::FileEntry;
+using esphome::waveshare_sd_card::ListStatus;
+
+static void test_normalize() {
+  assert(MountTable::normalize("") == "");
+  assert(MountTable::normalize("/") == "");
+  assert(MountTable::normalize("/ui/") == "/ui");
+  assert(MountTable::normalize("/ui//") == "/ui");
+  assert(MountTable::normalize("/a/b") == "/a/b");
+}
+
+static void test_resolve() {
+  DirectoryBackend root("/root"), ui("/ui"), icons("/icons");
+  MountTable table;
+  table.add("/", &root, MountPolicy{});
+  table.add("ui/", &ui, MountPolicy{});
+  table.add("/ui/icons", &icons, MountPolicy{});
+
+  std::string_view sub;
+  // A raiz vira o prefixo "" e cobre tudo que não tiver montagem mais específica.
+  const Mount *mount = table.resolve("", &sub);
+  assert(mount != nullptr && mount->backend == &root && sub.empty());
+  mount = table.resolve("/music/a.mp3", &sub);
+  assert(mount != nullptr && mount->backend == &root && sub == "/music/a.mp3");
+
+  // Prefixo mais longo vence.
+  mount = table.resolve("/ui", &sub);
+  assert(mount != nullptr && mount->backend == &ui && sub.empty());
+  mount = table.resolve("/ui/index.html", &sub);
+  assert(mount != nullptr && mount->backend == &ui && sub == "/index.html");
+  mount = table.resolve("/ui/icons/a.png", &sub);
+  assert(mount != nullptr && mount->backend == &icons && sub == "/a.png");
+
+  // Fronteira de segmento: "/ui" não cobre "/uix".
+  mount = table.resolve("/uix/a", &sub);
+  assert(mount != nullptr && mount->backend == &root && sub == "/uix/a");
+  mount = table.resolve("/ui/iconsx", &sub);
+  assert(mount != nullptr && mount->backend == &ui && sub == "/iconsx");
+
+  // Sem montagem na raiz, caminhos fora de qualquer prefixo não resolvem.
+  MountTable partial;
+  partial.add("/ui", &ui, MountPolicy{});
+  assert(partial.resolve("/uix", &sub) == nullptr);
+  assert(partial.resolve("/", nullptr) == nullptr);
+}
+
+static std::vector<std::string> children(const MountTable &table, std::string_view path) {
+  std::vector<std::string> names;
+  table.for_each_child(path, [&](std::string_view name) { names.emplace_back(name); });
+  return names;
+}
+
+static void test_for_each_child() {
+  DirectoryBackend backend("/x");
+  MountTable table;
+  table.add("/", &backend, MountPolicy{});
+  table.add("/ui", &backend, MountPolicy{});
+  table.add("/media", &backend, MountPolicy{});
+  table.add("/ui/icons", &backend, MountPolicy{});
+
+  // A própria raiz nunca aparece como filha.
+  assert((children(table, "") == std::vector<std::string>{"ui", "media"}));
+  assert((children(table, "/") == std::vector<std::string>{"ui", "media"}));
+  assert((children(table, "/ui/") == std::vector<std::string>{"icons"}));
+  assert(children(table, "/media").empty());
+  assert(children(table, "/u").empty());
+}
+
+// Backend cuja prontidão o teste controla, simulando o cartão montando no fast_boot.
+class FakeBackend : public DirectoryBackend {
+ public:
+  explicit FakeBackend(const std::string &base_path) : DirectoryBackend(base_path) {}
+  bool is_ready() const override {
+    this->ready_calls++;
+    return this->ready;
+  }
+
+  bool ready{false};
+  mutable int ready_calls{0};
+};
+
+static void test_resolve_backend() {
+  FakeBackend card("/sdcard"), flash("/spiffs");
+  flash.ready = true;
+  MountTable table;
+  table.add("/", &card, MountPolicy{8192, 0, false}, &flash);
+  table.add("/ro", &card, MountPolicy{1024, 60, true});
+
+  const Mount *mount = table.resolve("/a", nullptr);
+  ResolvedMount resolved = mount->resolve_backend();
+  assert(resolved.mount == mount && resolved.backend == &flash);
+  assert(resolved.fallback && resolved.read_only && resolved.ready);
+  assert(card.ready_calls == 1);
+
+  // A escolha já feita não muda quando o cartão fica pronto no meio da requisição.
+  card.ready = true;
+  assert(resolved.backend == &flash && resolved.read_only);
+
+  resolved = mount->resolve_backend();
+  assert(resolved.backend == &card && !resolved.fallback && !resolved.read_only && resolved.ready);
+
+  // Sem fallback, um backend indisponível continua selecionado, mas não pronto.
+  card.ready = false;
+  resolved = table.resolve("/ro/x", nullptr)->resolve_backend();
+  assert(resolved.backend == &card && !resolved.ready && resolved.read_only && !resolved.fallback);
+}
+
+static void write_file(const std::string &path, size_t size) {
+  FILE *f = fopen(path.c_str(), "w");
+  assert(f != nullptr);
+  for (size_t i = 0; i < size; i++)
+    fputc('x', f);
+  fclose(f);
+}
+
+static void test_list_files() {
+  char tmpl[] = "/tmp/mount_table_test_XXXXXX";
+  const char *dir = mkdtemp(tmpl);
+  assert(dir != nullptr);
+  const std::string base(dir);
+  write_file(base + "/a.txt", 5);
+  write_file(base + "/.hidden", 1);
+  assert(mkdir((base + "/sub").c_str(), 0755) == 0);
+
+  DirectoryBackend backend(base);
+  assert(backend.is_directory(base.c_str()));
+  assert(backend.is_directory((base + "/sub").c_str()));
+  assert(!backend.is_directory((base + "/a.txt").c_str()));
+  assert(!backend.is_directory((base + "/missing").c_str()));
+
+  std::map<std::string, FileEntry> entries;
+  ListStatus status = backend.list_files(base.c_str(), [&](const FileEntry &entry) {
+    entries[std::string(entry.name)] = FileEntry{{}, entry.is_directory, entry.size};
+  });
+  assert(status == esphome::waveshare_sd_card::LIST_OK);
+  assert(entries.size() == 2);
+  assert(!entries["a.txt"].is_directory && entries["a.txt"].size == 5);
+  assert(entries["sub"].is_directory);
+
+  int calls = 0;
+  status = backend.list_files((base + "/missing").c_str(), [&](const FileEntry &) { calls++; });
+  assert(status == esphome::waveshare_sd_card::LIST_OPEN_FAILED && calls == 0);
+
+  // Caminho base que não cabe no buffer: lista os nomes, mas sem stat.
+  std::string long_dir = base;
+  while (long_dir.size() + 2 < esphome::waveshare_sd_card::LIST_PATH_MAX) {
+    long_dir += "/" + std::string(60, 'd');
+    assert(mkdir(long_dir.c_str(), 0755) == 0);
+  }
+  write_file(long_dir + "/b.txt", 3);
+  entries.clear();
+  status = backend.list_files(long_dir.c_str(), [&](const FileEntry &entry) {
+    entries[std::string(entry.name)] = FileEntry{{}, entry.is_directory, entry.size};
+  });
+  assert(status == esphome::waveshare_sd_card::LIST_PATH_TOO_LONG);
+  assert(entries.size() == 1 && entries["b.txt"].size == 0);
+
+  std::string cmd = "rm -rf '" + base + "'";
+  assert(system(cmd.c_str()) == 0);
+}
+
+int main() {
+  test_normalize();
+  test_resolve();
+  test_for_each_child();
+  test_resolve_backend();
+  test_list_files();
+  printf("test_mount_table: OK\n");
+  return 0;
+}
@@ -0,0 +1,186 @@
+// Testes de host da RequestArena e da FileListing (heap_caps_malloc vem de stubs/).
+#undef NDEBUG
+#include "waveshare_sd_card/directory.h"
+#include "waveshare_sd_card/request_arena.h"
+#include "esp_heap_caps.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+
+using namespace esphome::waveshare_sd_card;
+
+static bool aligned(const void *ptr, size_t align) { return reinterpret_cast<uintptr_t>(ptr) % align == 0; }
+
+static void test_allocate_alignment() {
+  RequestArena arena(256, false);
+  assert(arena.is_valid() && !arena.in_psram());
+
+  void *a = arena.allocate(1, 1);
+  void *b = arena.allocate(8, 8);
+  void *c = arena.allocate(3, 1);
+  void *d = arena.allocate(16, 16);
+  assert(a != nullptr && b != nullptr && c != nullptr && d != nullptr);
+  assert(aligned(b, 8) && aligned(d, 16));
+  assert(static_cast<char *>(b) >= static_cast<char *>(a) + 1);
+  assert(aligned(arena.allocate(4), alignof(std::max_align_t)));
+
+  struct Pair {
+    uint32_t a;
+    uint16_t b;
+  };
+  Pair *pair = arena.create<Pair>(Pair{7, 9});
+  assert(pair != nullptr && aligned(pair, alignof(Pair)) && pair->a == 7 && pair->b == 9);
+}
+
+static void test_store_and_concat() {
+  RequestArena arena(64, false);
+  std::string_view stored = arena.store("abc");
+  assert(stored == "abc" && stored.data()[3] == '\0');
+
+  std::string_view joined = arena.concat({"/sdcard", "/", "music"});
+  assert(joined == "/sdcard/music" && joined.data()[joined.size()] == '\0');
+
+  std::string_view empty = arena.concat({});
+  assert(empty.data() != nullptr && empty.empty() && empty.data()[0] == '\0');
+}
+
+static void test_overflow_and_reset() {
+  // Sem PSRAM no host: cai para a RAM interna.
+  RequestArena arena(64, true);
+  assert(arena.is_valid() && !arena.in_psram() && arena.block_size() == 64);
+
+  char *first = static_cast<char *>(arena.allocate(48, 1));
+  assert(first != nullptr && arena.used() == 48);
+
+  // Não cabe no bloco fixo: encadeia um bloco extra.
+  char *second = static_cast<char *>(arena.allocate(32, 1));
+  assert(second != nullptr && arena.used() == 80);
+  // Maior que o próprio block_size: o bloco extra cresce para caber.
+  char *big = static_cast<char *>(arena.allocate(1000, 8));
+  assert(big != nullptr && aligned(big, 8));
+  for (int i = 0; i < 1000; i++)
+    big[i] = 'x';
+  assert(arena.used() >= 1080 && arena.peak() == arena.used());
+
+  size_t peak = arena.peak();
+  arena.reset();
+  assert(arena.used() == 0 && arena.peak() == peak);
+  // O bloco fixo é reaproveitado a partir do início.
+  assert(arena.allocate(48, 1) == first);
+
+  {
+    ArenaScope scope(arena);
+    assert(arena.allocate(200, 1) != nullptr);
+  }
+  assert(arena.used() == 0);
+}
+
+static void test_exhaustion() {
+  RequestArena arena(32, false);
+  stub_heap_caps_allocs_left = 0;
+  assert(arena.allocate(16, 1) != nullptr);
+  // Sem memória para um bloco extra.
+  assert(arena.allocate(64, 1) == nullptr);
+  assert(arena.concat({std::string(100, 'a')}).data() == nullptr);
+  stub_heap_caps_allocs_left = -1;
+
+  stub_heap_caps_allocs_left = 0;
+  RequestArena failed(32, false);
+  stub_heap_caps_allocs_left = -1;
+  assert(!failed.is_valid());
+  assert(failed.allocate(1, 1) == nullptr);
+  failed.reset();
+}
+
+static void test_file_listing_add() {
+  RequestArena arena(256, false);
+  FileListing listing;
+  assert(listing.empty() && !listing.is_truncated());
+
+  char name[] = "a.txt";
+  assert(listing.add(arena, FileEntry{name, false, 5}));
+  // O nome é copiado para a arena, não aponta para o buffer de origem.
+  name[0] = 'z';
+  assert(listing.add(arena, FileEntry{"sub", true, 0}));
+  assert(listing.size() == 2);
+
+  auto it = listing.begin();
+  assert(it->name == "a.txt" && !it->is_directory && it->size == 5);
+  ++it;
+  assert(it->name == "sub" && it->is_directory);
+  ++it;
+  assert(!(it != listing.end()));
+}
+
+static void write_file(const std::string &path, size_t size) {
+  FILE *f = fopen(path.c_str(), "w");
+  assert(f != nullptr);
+  for (size_t i = 0; i < size; i++)
+    fputc('x', f);
+  fclose(f);
+}
+
+static void test_list_directory_arena() {
+  char tmpl[] = "/tmp/request_arena_test_XXXXXX";
+  const char *dir = mkdtemp(tmpl);
+  assert(dir != nullptr);
+  const std::string base(dir);
+  const int files = 20;
+  for (int i = 0; i < files; i++)
+    write_file(base + "/file_with_a_long_name_" + std::to_string(i) + ".bin", i);
+  assert(mkdir((base + "/sub").c_str(), 0755) == 0);
+
+  RequestArena arena(128, false);
+  {
+    ArenaScope scope(arena);
+    FileListing listing = list_directory(base.c_str(), arena);
+    assert(listing.is_opened() && listing.status() == LIST_OK && !listing.is_truncated());
+    assert(listing.size() == files + 1);
+    std::map<std::string, FileEntry> entries;
+    for (const auto &entry : listing)
+      entries[std::string(entry.name)] = entry;
+    assert(entries["sub"].is_directory);
+    assert(entries["file_with_a_long_name_7.bin"].size == 7);
+  }
+
+  {
+    ArenaScope scope(arena);
+    FileListing listing = list_directory((base + "/missing").c_str(), arena);
+    assert(!listing.is_opened() && listing.status() == LIST_OPEN_FAILED && listing.empty());
+  }
+
+  {
+    // Arena sem blocos extras: a listagem para de copiar, mas mantém o que já coube.
+    ArenaScope scope(arena);
+    stub_heap_caps_allocs_left = 0;
+    FileListing listing = list_directory(base.c_str(), arena);
+    stub_heap_caps_allocs_left = -1;
+    assert(listing.is_opened() && listing.is_truncated());
+    assert(listing.size() > 0 && listing.size() < static_cast<size_t>(files + 1));
+    size_t count = 0;
+    for (const auto &entry : listing) {
+      assert(!entry.name.empty() && entry.name.data()[entry.name.size()] == '\0');
+      count++;
+    }
+    assert(count == listing.size());
+  }
+
+  std::string cmd = "rm -rf '" + base + "'";
+  assert(system(cmd.c_str()) == 0);
+}
+
+int main() {
+  test_allocate_alignment();
+  test_store_and_concat();
+  test_overflow_and_reset();
+  test_exhaustion();
+  test_file_listing_add();
+  test_list_directory_arena();
+  printf("test_request_arena: OK\n");
+  return 0;
+}